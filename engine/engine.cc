@@ -1,6 +1,11 @@
 #include "engine.h"
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <stdint.h>
 #include <vector>
 
@@ -266,6 +271,8 @@ static bool IsAttacked(Position const &position, board_coord row,
       enemy_color == Player::kWhite ? Piece::kWhiteQueen : Piece::kBlackQueen;
   Piece enemy_pawn =
       enemy_color == Player::kWhite ? Piece::kWhitePawn : Piece::kBlackPawn;
+  Piece enemy_king =
+      enemy_color == Player::kWhite ? Piece::kWhiteKing : Piece::kBlackKing;
 
   if (GetPiece(position, row - 2, file - 1) == enemy_knight)
     return true;
@@ -310,6 +317,13 @@ static bool IsAttacked(Position const &position, board_coord row,
   if (piece == enemy_bishop || piece == enemy_queen)
     return true;
 
+  for (board_coord row_diff = -1; row_diff <= 1; row_diff++) {
+    for (board_coord file_diff = -1; file_diff <= 1; file_diff++) {
+      if (GetPiece(position, row + row_diff, file + file_diff) == enemy_king)
+        return true;
+    }
+  }
+
   board_coord pawn_row_delta = enemy_color == Player::kWhite ? -1 : 1;
   if (GetPiece(position, row + pawn_row_delta, file - 1) == enemy_pawn)
     return true;
@@ -368,7 +382,57 @@ static bool IsLegalPosition(Position const &position) {
   return false;
 }
 
-static constexpr int kInfiniteScore = 9999;
+std::vector<Move> GetLegalMoves(Position const &position) {
+  std::vector<Move> moves = GetPseudoLegalMoves(position);
+  std::erase_if(moves, [&position](Move const &move) {
+    Position next = position;
+    PlayMove(next, move);
+    return !IsLegalPosition(next);
+  });
+  return moves;
+}
+
+bool IsInCheck(Position const &position) {
+  Piece own_king = position.active_player == Player::kWhite
+                       ? Piece::kWhiteKing
+                       : Piece::kBlackKing;
+
+  for (board_coord row = 0; row < kBoardSize; row++) {
+    for (board_coord file = 0; file < kBoardSize; file++) {
+      if (position.board[BoardIndex(row, file)] == own_king) {
+        return IsAttacked(position, row, file,
+                          InverseColor(position.active_player));
+      }
+    }
+  }
+
+  return false;
+}
+
+static constexpr int kInfiniteScore = 32000;
+static constexpr int kMateScore = 30000;
+
+static bool IsMateScore(int score) {
+  return std::abs(score) >= kMateScore - kMaxPly;
+}
+
+// Mate scores are stored relative to the stored position rather than the
+// root, so that they stay valid when reached through another path.
+static int ScoreToHash(int score, int ply) {
+  if (IsMateScore(score))
+    return score > 0 ? score + ply : score - ply;
+  return score;
+}
+
+static int ScoreFromHash(int score, int ply) {
+  if (IsMateScore(score))
+    return score > 0 ? score - ply : score + ply;
+  return score;
+}
+
+static bool IsSameMove(Move a, Move b) {
+  return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+}
 
 static int ScorePosition(Position const &position) {
   int score = 0;
@@ -383,39 +447,550 @@ static int ScorePosition(Position const &position) {
   return score;
 }
 
+static bool HasPieces(Position const &position, Player player) {
+  for (Piece piece : position.board) {
+    if (piece != Piece::kNone && GetPieceColor(piece) == player &&
+        !IsPawn(piece) && BlackToWhite(piece) != Piece::kWhiteKing) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static constexpr int kFreePassedPawnBonus = 20;
+
+static constexpr int kHashMoveScore = 1 << 30;
+static constexpr int kPvMoveScore = kHashMoveScore - 1;
+static constexpr int kTacticalMoveScore = 1 << 20;
+static constexpr int kHistoryMax = 16384;
+
+// Margins and move counts are indexed by the remaining depth.
+static constexpr int kReverseFutilityMaxDepth = 6;
+static constexpr int kReverseFutilityMargin = 100;
+static constexpr int kRazoringMargins[] = {0, 300, 550};
+static constexpr int kFutilityMargins[] = {0, 150, 300, 450};
+static constexpr int kLateMovePruningCounts[] = {0, 6, 10, 16};
+static constexpr int kNullMoveMinDepth = 3;
+static constexpr int kNullMoveVerificationDepth = 8;
+static constexpr int kLateMoveReductionMinDepth = 3;
+static constexpr int kLateMoveReductionMinMoves = 3;
+static constexpr int kReductionTableSize = 64;
+
+// Reductions grow with the logarithm of both the depth and the move number.
+static auto const kReductions = [] {
+  std::array<std::array<int, kReductionTableSize>, kReductionTableSize> table{};
+  for (int depth = 1; depth < kReductionTableSize; depth++) {
+    for (int moves = 1; moves < kReductionTableSize; moves++) {
+      table[depth][moves] =
+          (int)(0.75 + std::log(depth) * std::log(moves) / 2.25);
+    }
+  }
+  return table;
+}();
+
+static bool IsTactical(Position const &position, Move move) {
+  return position.board[move.to] != Piece::kNone || move.promotion != 0;
+}
+
+static int MoveOrderScore(Position const &position, Move move) {
+  int score = 0;
+  Piece victim = position.board[move.to];
+  if (victim != Piece::kNone) {
+    // Most valuable victim, least valuable attacker.
+    score += kTacticalMoveScore + 10 * GetPieceValue(victim) -
+             GetPieceValue(position.board[move.from]);
+  }
+  if (move.promotion != 0)
+    score += kTacticalMoveScore + 10 * move.promotion;
+  return score;
+}
+
+static std::chrono::milliseconds AllocateTime(SearchLimits const &limits) {
+  using std::chrono::milliseconds;
+
+  if (limits.move_time.count() > 0)
+    return limits.move_time;
+  if (limits.time_left.count() <= 0)
+    return milliseconds(0);
+
+  // Leave some room for the communication overhead.
+  milliseconds budget = limits.time_left / 30 + limits.increment / 2;
+  budget = std::min(budget, limits.time_left / 2) - milliseconds(10);
+  return std::max(budget, milliseconds(1));
+}
+
+Engine::Engine() { _hash_table.Resize(kDefaultHashMegabytes); }
+
+Engine::~Engine() { Stop(); }
+
+void Engine::SetHashSize(size_t megabytes) {
+  Stop();
+  _hash_table.Resize(megabytes);
+}
+
+void Engine::NewGame() {
+  Stop();
+  _hash_table.Clear();
+  std::memset(_history, 0, sizeof(_history));
+}
+
+bool Engine::SaveHash(std::string const &path) {
+  Stop();
+  return _hash_table.Save(path);
+}
+
+bool Engine::LoadHash(std::string const &path) {
+  Stop();
+  return _hash_table.Load(path);
+}
+
+bool Engine::SetOption(std::string const &name, std::string const &value) {
+  for (SearchOptionInfo const &option : kSearchOptions) {
+    if (name == option.name) {
+      if (value != "true" && value != "false")
+        return false;
+      Stop();
+      _options.*option.value = value == "true";
+      return true;
+    }
+  }
+  return false;
+}
+
+// Score from the point of view of the side to move.
+int Engine::Evaluate(Position const &position) {
+  PawnEntry const &pawns = _pawn_table.Probe(position);
+  int score = ScorePosition(position) + pawns.score;
+
+  // Depends on the other pieces, so it can't be cached with the pawns.
+  for (uint64_t passed = pawns.passed_pawns; passed != 0;
+       passed &= passed - 1) {
+    board_index square = std::countr_zero(passed);
+    bool white = IsWhitePiece(position.board[square]);
+    board_index stop = square + (white ? kBoardSize : -kBoardSize);
+    if (stop >= 0 && stop < kBoardSquares &&
+        position.board[stop] == Piece::kNone) {
+      score += white ? kFreePassedPawnBonus : -kFreePassedPawnBonus;
+    }
+  }
+
+  return position.active_player == Player::kWhite ? score : -score;
+}
+
 void Engine::EnterPosition(Position const &position) {
+  // The search thread reads the position until it is over.
+  Stop();
   _current_position = position;
 }
 
-void Engine::StartSearch() {}
+void Engine::StartSearch(SearchLimits const &limits,
+                         BestMoveCallback on_best_move, InfoCallback on_info) {
+  Stop();
+
+  _limits = limits;
+  _on_best_move = std::move(on_best_move);
+  _on_info = std::move(on_info);
+  _stop = false;
+  _pondering = limits.ponder;
+  _start_time = std::chrono::steady_clock::now();
+  _deadline = std::chrono::steady_clock::time_point::max()
+                  .time_since_epoch()
+                  .count();
+  if (!_pondering)
+    StartClock();
+
+  _search_thread = std::thread(&Engine::Search, this);
+}
+
+void Engine::PonderHit() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_pondering)
+    return;
+
+  _pondering = false;
+  StartClock();
+  _wake.notify_all();
+}
+
+void Engine::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+
+  if (_search_thread.joinable())
+    _search_thread.join();
+}
 
 Move Engine::GetBestMove() {
-  auto moves = GetPseudoLegalMoves(_current_position);
+  if (_search_thread.joinable())
+    _search_thread.join();
+  return _best_move;
+}
 
-  std::sort(moves.begin(), moves.end(), [this](Move const &a, Move const &b) {
-    Position position_a, position_b;
-    position_a = position_b = _current_position;
+Move Engine::GetPonderMove() {
+  if (_search_thread.joinable())
+    _search_thread.join();
+  return _ponder_move;
+}
 
-    PlayMove(position_a, a);
-    PlayMove(position_b, b);
+// Must be called with _mutex held once the search thread is running.
+void Engine::StartClock() {
+  _clock_start = std::chrono::steady_clock::now();
+  _time_budget = AllocateTime(_limits);
+  if (_time_budget.count() > 0) {
+    _deadline = (_clock_start + _time_budget).time_since_epoch().count();
+  }
+}
 
-    int score_a = ScorePosition(position_a);
-    int score_b = ScorePosition(position_b);
+bool Engine::OutOfTime() const {
+  return std::chrono::steady_clock::now().time_since_epoch().count() >=
+         _deadline.load(std::memory_order_relaxed);
+}
 
-    if (_current_position.active_player == Player::kWhite) {
-      return score_b < score_a;
-    } else {
-      return score_a < score_b;
+void Engine::OrderMoves(Position const &position, std::vector<Move> &moves,
+                        int ply, Move hash_move) {
+  Move pv_move = ply < (int)_root_pv.size() ? _root_pv[ply] : Move();
+
+  auto score = [&](Move const &move) {
+    if (!IsNullMove(hash_move) && IsSameMove(move, hash_move))
+      return kHashMoveScore;
+    if (!IsNullMove(pv_move) && IsSameMove(move, pv_move))
+      return kPvMoveScore;
+    if (IsTactical(position, move))
+      return MoveOrderScore(position, move);
+    return _history[(uint8_t)position.active_player][move.from][move.to];
+  };
+
+  std::vector<std::pair<int, Move>> scored_moves;
+  scored_moves.reserve(moves.size());
+  for (Move const &move : moves)
+    scored_moves.emplace_back(score(move), move);
+
+  std::stable_sort(scored_moves.begin(), scored_moves.end(),
+                   [](auto const &a, auto const &b) {
+                     return a.first > b.first;
+                   });
+  for (size_t i = 0; i < moves.size(); i++)
+    moves[i] = scored_moves[i].second;
+}
+
+void Engine::UpdateHistory(Player player, Move move, int bonus) {
+  int &entry = _history[(uint8_t)player][move.from][move.to];
+  // Stays within kHistoryMax, and old results fade as new ones come in.
+  entry += bonus - entry * std::abs(bonus) / kHistoryMax;
+}
+
+void Engine::Search() {
+  _nodes = 0;
+  _root_pv.clear();
+  _best_move = Move();
+  _ponder_move = Move();
+
+  for (auto &from : _history) {
+    for (auto &to : from) {
+      for (int &entry : to)
+        entry /= 2;
     }
-  });
+  }
 
-  for (Move const &move : moves) {
+  // Have something to play even if the search is stopped right away.
+  for (Move const &move : GetPseudoLegalMoves(_current_position)) {
     Position position = _current_position;
     PlayMove(position, move);
+    if (IsLegalPosition(position)) {
+      _best_move = move;
+      break;
+    }
+  }
+
+  int max_depth = kMaxPly - 1;
+  if (_limits.depth > 0)
+    max_depth = std::min(_limits.depth, max_depth);
+
+  for (int depth = 1; depth <= max_depth && !IsNullMove(_best_move);
+       depth++) {
+    int score = AlphaBeta(_current_position, depth, 0, -kInfiniteScore,
+                          kInfiniteScore, true);
+    // Results of an interrupted iteration are not reliable.
+    if (_stop)
+      break;
+
+    _root_pv.assign(_pv[0], _pv[0] + _pv_length[0]);
+    if (!_root_pv.empty()) {
+      _best_move = _root_pv[0];
+      _ponder_move = _root_pv.size() > 1 ? _root_pv[1] : Move();
+    }
+
+    // The PV is cut short by hash table hits, the reply may still be there.
+    if (_root_pv.size() == 1) {
+      Position next = _current_position;
+      PlayMove(next, _best_move);
+      TTEntry const *entry = _hash_table.Probe(next.hash);
+      if (entry != nullptr && !IsNullMove(entry->move))
+        _ponder_move = entry->move;
+    }
+
+    if (_on_info) {
+      SearchInfo info;
+      info.depth = depth;
+      info.score_cp = score;
+      info.mate = 0;
+      if (IsMateScore(score)) {
+        info.mate = score > 0 ? (kMateScore - score + 1) / 2
+                              : -(kMateScore + score) / 2;
+      }
+      info.nodes = _nodes;
+      info.time = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - _start_time);
+      info.pv = _root_pv;
+      _on_info(info);
+    }
+
+    // A deeper search will not find a shorter mate.
+    if (IsMateScore(score))
+      break;
+
+    // Not enough time left to finish another iteration.
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_pondering && _time_budget.count() > 0 &&
+        std::chrono::steady_clock::now() - _clock_start > _time_budget / 2) {
+      break;
+    }
+  }
+
+  {
+    // The best move can't be sent while pondering or in an infinite search.
+    std::unique_lock<std::mutex> lock(_mutex);
+    _wake.wait(lock, [this] {
+      return _stop || (!_pondering && !_limits.infinite);
+    });
+  }
+
+  if (_on_best_move)
+    _on_best_move(_best_move, _ponder_move);
+}
+
+int Engine::AlphaBeta(Position const &position, int depth, int ply, int alpha,
+                      int beta, bool allow_null_move) {
+  _pv_length[ply] = ply;
+
+  if (depth <= 0)
+    return Quiescence(position, ply, alpha, beta);
+
+  if ((_nodes++ & 2047) == 0 && OutOfTime())
+    _stop = true;
+  if (_stop)
+    return 0;
+  if (ply >= kMaxPly - 1)
+    return Evaluate(position);
+
+  Move hash_move = Move();
+  TTEntry const *entry = _hash_table.Probe(position.hash);
+  if (entry != nullptr) {
+    hash_move = entry->move;
+
+    // Keep searching at the root so that there is a best move.
+    int score = ScoreFromHash(entry->score, ply);
+    if (ply > 0 && entry->depth >= depth &&
+        (entry->bound == Bound::kExact ||
+         (entry->bound == Bound::kLower && score >= beta) ||
+         (entry->bound == Bound::kUpper && score <= alpha))) {
+      return score;
+    }
+  }
 
-    if (IsLegalPosition(position))
-      return move;
+  // Only nodes searched with an open window can end up on the PV. The others
+  // just have to prove a bound, which lets them cut corners.
+  bool pv_node = beta - alpha > 1;
+  bool in_check = IsInCheck(position);
+  int static_eval = in_check ? -kInfiniteScore : Evaluate(position);
+
+  if (!pv_node && !in_check) {
+    // Even giving away a margin for every remaining ply stays above beta.
+    if (_options.reverse_futility_pruning &&
+        depth <= kReverseFutilityMaxDepth && !IsMateScore(beta) &&
+        static_eval - kReverseFutilityMargin * depth >= beta) {
+      return static_eval;
+    }
+
+    // Far below alpha, only captures could save the position.
+    if (_options.razoring && depth < (int)std::size(kRazoringMargins) &&
+        static_eval + kRazoringMargins[depth] < alpha) {
+      int score = Quiescence(position, ply, alpha - 1, alpha);
+      if (_stop)
+        return 0;
+      if (score < alpha)
+        return score;
+    }
+
+    // If passing the turn still holds beta, a real move would too. This
+    // fails in zugzwang, which is rare while there are pieces on the board.
+    if (_options.null_move_pruning && allow_null_move && ply > 0 &&
+        depth >= kNullMoveMinDepth && static_eval >= beta &&
+        HasPieces(position, position.active_player)) {
+      int reduction = 2 + depth / 6;
+      Position next = position;
+      PlayNullMove(next);
+      int score = -AlphaBeta(next, depth - 1 - reduction, ply + 1, -beta,
+                             -beta + 1, false);
+
+      // Deep cutoffs are verified with a reduced search of the real moves,
+      // where a missed zugzwang would cost the most.
+      if (score >= beta && depth >= kNullMoveVerificationDepth) {
+        score = AlphaBeta(position, depth - 1 - reduction, ply, beta - 1, beta,
+                          false);
+        _pv_length[ply] = ply;
+      }
+      if (_stop)
+        return 0;
+      if (score >= beta)
+        return IsMateScore(score) ? beta : score;
+    }
+  }
+
+  std::vector<Move> moves = GetPseudoLegalMoves(position);
+  OrderMoves(position, moves, ply, hash_move);
+
+  // Quiet moves can't make up the difference to alpha.
+  bool futile = _options.futility_pruning && !pv_node && !in_check &&
+                depth < (int)std::size(kFutilityMargins) &&
+                static_eval + kFutilityMargins[depth] <= alpha;
+  Player player = position.active_player;
+
+  int original_alpha = alpha;
+  Move best_move = Move();
+  int legal_moves = 0;
+  std::vector<Move> quiet_moves;
+  for (Move const &move : moves) {
+    Position next = position;
+    PlayMove(next, move);
+    if (!IsLegalPosition(next))
+      continue;
+    legal_moves++;
+
+    bool quiet = !IsTactical(position, move);
+    bool gives_check = IsInCheck(next);
+    if (quiet && !gives_check && !in_check && !pv_node) {
+      if (futile)
+        continue;
+      if (_options.late_move_pruning &&
+          depth < (int)std::size(kLateMovePruningCounts) &&
+          legal_moves > kLateMovePruningCounts[depth]) {
+        continue;
+      }
+    }
+
+    int score;
+    if (legal_moves == 1) {
+      score = -AlphaBeta(next, depth - 1, ply + 1, -beta, -alpha, true);
+    } else {
+      // Late quiet moves are rarely the best, so they are first searched
+      // shallower. Moves with a good history are reduced less.
+      int reduction = 0;
+      if (_options.late_move_reductions && quiet && !in_check &&
+          !gives_check && depth >= kLateMoveReductionMinDepth &&
+          legal_moves > kLateMoveReductionMinMoves) {
+        reduction = kReductions[std::min(depth, kReductionTableSize - 1)]
+                               [std::min(legal_moves, kReductionTableSize - 1)];
+        reduction -= _history[(uint8_t)player][move.from][move.to] /
+                     (kHistoryMax / 2);
+        if (pv_node)
+          reduction--;
+        reduction = std::clamp(reduction, 0, depth - 2);
+      }
+
+      // Prove that the move is not better than alpha with a null window,
+      // searching again at full depth and width when it turns out to be.
+      score = -AlphaBeta(next, depth - 1 - reduction, ply + 1, -alpha - 1,
+                         -alpha, true);
+      if (score > alpha && reduction > 0) {
+        score =
+            -AlphaBeta(next, depth - 1, ply + 1, -alpha - 1, -alpha, true);
+      }
+      if (score > alpha && score < beta)
+        score = -AlphaBeta(next, depth - 1, ply + 1, -beta, -alpha, true);
+    }
+    if (_stop)
+      return 0;
+
+    if (quiet)
+      quiet_moves.push_back(move);
+
+    if (score > alpha) {
+      alpha = score;
+      best_move = move;
+
+      _pv[ply][ply] = move;
+      for (int i = ply + 1; i < _pv_length[ply + 1]; i++)
+        _pv[ply][i] = _pv[ply + 1][i];
+      _pv_length[ply] = _pv_length[ply + 1];
+
+      if (alpha >= beta) {
+        if (quiet) {
+          int bonus = std::min(depth * depth, kHistoryMax / 4);
+          for (Move const &quiet_move : quiet_moves) {
+            UpdateHistory(player, quiet_move,
+                          IsSameMove(quiet_move, move) ? bonus : -bonus);
+          }
+        }
+        break;
+      }
+    }
+  }
+
+  if (legal_moves == 0)
+    return in_check ? -kMateScore + ply : 0;
+
+  Bound bound = Bound::kExact;
+  if (alpha >= beta) {
+    bound = Bound::kLower;
+  } else if (alpha <= original_alpha) {
+    bound = Bound::kUpper;
+  }
+  _hash_table.Store(position.hash, best_move, ScoreToHash(alpha, ply), depth,
+                    bound);
+
+  return alpha;
+}
+
+int Engine::Quiescence(Position const &position, int ply, int alpha,
+                       int beta) {
+  _pv_length[ply] = ply;
+
+  if ((_nodes++ & 2047) == 0 && OutOfTime())
+    _stop = true;
+  if (_stop)
+    return 0;
+
+  int stand_pat = Evaluate(position);
+  if (ply >= kMaxPly - 1 || stand_pat >= beta)
+    return stand_pat;
+  alpha = std::max(alpha, stand_pat);
+
+  std::vector<Move> moves = GetPseudoLegalMoves(position);
+  std::erase_if(moves, [&position](Move const &move) {
+    return !IsTactical(position, move);
+  });
+  OrderMoves(position, moves, ply, Move());
+
+  for (Move const &move : moves) {
+    Position next = position;
+    PlayMove(next, move);
+    if (!IsLegalPosition(next))
+      continue;
+
+    int score = -Quiescence(next, ply + 1, -beta, -alpha);
+    if (_stop)
+      return 0;
+
+    if (score > alpha) {
+      alpha = score;
+      if (alpha >= beta)
+        break;
+    }
   }
 
-  return Move();
+  return alpha;
 }
\ No newline at end of file
@@ -1,34 +1,148 @@
 #pragma once
 
+#include "pawns.h"
 #include "position.h"
-#include <unordered_set>
+#include "transposition_table.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-struct HashEntry {
-  Position position;
+constexpr int kMaxPly = 128;
+constexpr size_t kDefaultHashMegabytes = 16;
+
+std::vector<Move> GetLegalMoves(Position const &position);
+bool IsInCheck(Position const &position);
+
+struct SearchLimits {
+  // Maximum search depth, 0 means no limit.
+  int depth = 0;
+  // Fixed time for the move. Overrides the clock based allocation.
+  std::chrono::milliseconds move_time{0};
+  // Clock of the side to move.
+  std::chrono::milliseconds time_left{0};
+  std::chrono::milliseconds increment{0};
+  // Search until stopped.
+  bool infinite = false;
+  // Search on the opponent's time. The clock starts on PonderHit().
+  bool ponder = false;
 };
 
-template <> struct std::hash<HashEntry> {
-  std::size_t operator()(HashEntry const &e) const noexcept {
-    std::size_t hash_value = 0;
-    for (uint8_t i = 0; i < kBoardSquares; i++) {
-      hash_value <<= 1;
-      hash_value ^= (std::size_t)e.position.board[i];
-    }
+// Selective search features. All are on by default; they can be turned off
+// to measure what they are worth.
+struct SearchOptions {
+  bool null_move_pruning = true;
+  bool late_move_reductions = true;
+  bool reverse_futility_pruning = true;
+  bool futility_pruning = true;
+  bool late_move_pruning = true;
+  bool razoring = true;
+};
 
-    hash_value <<= 1;
-    hash_value ^= (std::size_t)e.position.active_player;
+struct SearchOptionInfo {
+  char const *name;
+  bool SearchOptions::*value;
+};
 
-    return hash_value;
-  }
+constexpr SearchOptionInfo kSearchOptions[] = {
+    {"NullMovePruning", &SearchOptions::null_move_pruning},
+    {"LateMoveReductions", &SearchOptions::late_move_reductions},
+    {"ReverseFutilityPruning", &SearchOptions::reverse_futility_pruning},
+    {"FutilityPruning", &SearchOptions::futility_pruning},
+    {"LateMovePruning", &SearchOptions::late_move_pruning},
+    {"Razoring", &SearchOptions::razoring},
+};
+
+struct SearchInfo {
+  int depth;
+  int score_cp;
+  // Moves to mate, negative if getting mated. 0 when no mate was found.
+  int mate;
+  uint64_t nodes;
+  std::chrono::milliseconds time;
+  std::vector<Move> pv;
 };
 
 class Engine {
 public:
+  using BestMoveCallback = std::function<void(Move best, Move ponder)>;
+  using InfoCallback = std::function<void(SearchInfo const &)>;
+
+  Engine();
+  ~Engine();
+
+  // Reallocates the transposition table, losing its contents.
+  void SetHashSize(size_t megabytes);
+  TranspositionTable const &GetHashTable() const { return _hash_table; }
+  // Stops the search and forgets everything learned in the previous game.
+  void NewGame();
+  // Stop the search and save or restore the transposition table, so that
+  // a later session can continue the analysis where this one left off.
+  bool SaveHash(std::string const &path);
+  bool LoadHash(std::string const &path);
+  // Sets one of kSearchOptions from "true" or "false". Returns false for
+  // unknown options and any other value.
+  bool SetOption(std::string const &name, std::string const &value);
+
+  // Stops the search before replacing the position.
   void EnterPosition(Position const &position);
-  void StartSearch();
+  // Starts searching the entered position in the background. on_best_move is
+  // called from the search thread once the search is over. Ponder and
+  // infinite searches are only over after PonderHit() or Stop().
+  void StartSearch(SearchLimits const &limits,
+                   BestMoveCallback on_best_move = nullptr,
+                   InfoCallback on_info = nullptr);
+  // The opponent played the expected move. The ongoing search continues as a
+  // timed search from where it is.
+  void PonderHit();
+  void Stop();
+  // Waits for the search to finish.
   Move GetBestMove();
+  Move GetPonderMove();
 
 private:
+  void Search();
+  int AlphaBeta(Position const &position, int depth, int ply, int alpha,
+                int beta, bool allow_null_move);
+  int Quiescence(Position const &position, int ply, int alpha, int beta);
+  int Evaluate(Position const &position);
+  void OrderMoves(Position const &position, std::vector<Move> &moves, int ply,
+                  Move hash_move);
+  void UpdateHistory(Player player, Move move, int bonus);
+  bool OutOfTime() const;
+  void StartClock();
+
   Position _current_position;
-  std::unordered_set<HashEntry> _hash_table;
+  TranspositionTable _hash_table;
+  PawnHashTable _pawn_table;
+  SearchOptions _options;
+  // How often quiet moves have caused cutoffs, by player, from and to.
+  int _history[2][kBoardSquares][kBoardSquares] = {};
+
+  SearchLimits _limits;
+  BestMoveCallback _on_best_move;
+  InfoCallback _on_info;
+  std::thread _search_thread;
+
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::atomic<bool> _stop = false;
+  std::atomic<bool> _pondering = false;
+  // steady_clock ticks, max when the search has no deadline.
+  std::atomic<std::chrono::steady_clock::rep> _deadline;
+  std::chrono::steady_clock::time_point _start_time;
+  std::chrono::steady_clock::time_point _clock_start;
+  std::chrono::milliseconds _time_budget{0};
+
+  uint64_t _nodes = 0;
+  Move _best_move = Move();
+  Move _ponder_move = Move();
+  Move _pv[kMaxPly][kMaxPly];
+  int _pv_length[kMaxPly];
+  // Principal variation of the last completed iteration, used for ordering.
+  std::vector<Move> _root_pv;
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(std::string const &path) {
+  Close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  _file_handle = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    Close();
+    return false;
+  }
+  _size = (size_t)size.QuadPart;
+  if (_size == 0)
+    return true;
+
+  _mapping_handle =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mapping_handle == nullptr) {
+    Close();
+    return false;
+  }
+  _data = MapViewOfFile(_mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if (_data == nullptr) {
+    Close();
+    return false;
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return false;
+  }
+  _size = (size_t)info.st_size;
+  if (_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file alive.
+  close(fd);
+  if (data == MAP_FAILED) {
+    _size = 0;
+    return false;
+  }
+  _data = data;
+  // Mapped files are read front to back.
+  madvise(_data, _size, MADV_SEQUENTIAL);
+#endif
+
+  return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+  if (_data != nullptr)
+    UnmapViewOfFile(_data);
+  if (_mapping_handle != nullptr)
+    CloseHandle(_mapping_handle);
+  if (_file_handle != nullptr)
+    CloseHandle(_file_handle);
+  _mapping_handle = nullptr;
+  _file_handle = nullptr;
+#else
+  if (_data != nullptr)
+    munmap(_data, _size);
+#endif
+  _data = nullptr;
+  _size = 0;
+}
\ No newline at end of file
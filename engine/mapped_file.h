@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+  ~MappedFile();
+
+  bool Open(std::string const &path);
+  void Close();
+
+  void const *GetData() const { return _data; }
+  size_t GetSize() const { return _size; }
+
+private:
+  void *_data = nullptr;
+  size_t _size = 0;
+#ifdef _WIN32
+  void *_file_handle = nullptr;
+  void *_mapping_handle = nullptr;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "pawns.h"
+
+static constexpr size_t kPawnHashEntries = 1 << 14;
+
+static constexpr int kDoubledPawnPenalty = 10;
+static constexpr int kIsolatedPawnPenalty = 15;
+static constexpr int kBackwardPawnPenalty = 10;
+static constexpr int kPassedPawnBonus[kBoardSize] = {0,  5,  10,  20,
+                                                     35, 60, 100, 0};
+
+static bool IsPassed(Position const &position, board_coord row,
+                     board_coord file, board_coord forward, Piece enemy_pawn) {
+  for (board_coord r = row + forward; r >= 0 && r < kBoardSize; r += forward) {
+    for (board_coord f = file - 1; f <= file + 1; f++) {
+      if (f >= 0 && f < kBoardSize &&
+          position.board[BoardIndex(r, f)] == enemy_pawn)
+        return false;
+    }
+  }
+  return true;
+}
+
+// No friendly pawn on an adjacent file can support it, and advancing it runs
+// into an enemy pawn attack.
+static bool IsBackward(Position const &position, board_coord row,
+                       board_coord file, board_coord forward, Piece own_pawn,
+                       Piece enemy_pawn) {
+  for (board_coord r = row; r >= 0 && r < kBoardSize; r -= forward) {
+    for (board_coord f = file - 1; f <= file + 1; f += 2) {
+      if (f >= 0 && f < kBoardSize &&
+          position.board[BoardIndex(r, f)] == own_pawn)
+        return false;
+    }
+  }
+
+  board_coord attacker_row = row + 2 * forward;
+  if (attacker_row < 0 || attacker_row >= kBoardSize)
+    return false;
+  for (board_coord f = file - 1; f <= file + 1; f += 2) {
+    if (f >= 0 && f < kBoardSize &&
+        position.board[BoardIndex(attacker_row, f)] == enemy_pawn)
+      return true;
+  }
+  return false;
+}
+
+static PawnEntry EvaluatePawns(Position const &position) {
+  int pawns_on_file[2][kBoardSize] = {};
+  for (board_coord row = 0; row < kBoardSize; row++) {
+    for (board_coord file = 0; file < kBoardSize; file++) {
+      Piece piece = position.board[BoardIndex(row, file)];
+      if (IsPawn(piece))
+        pawns_on_file[(uint8_t)GetPieceColor(piece)][file]++;
+    }
+  }
+
+  PawnEntry entry{.key = position.pawn_hash, .score = 0, .passed_pawns = 0};
+  for (board_coord row = 0; row < kBoardSize; row++) {
+    for (board_coord file = 0; file < kBoardSize; file++) {
+      Piece piece = position.board[BoardIndex(row, file)];
+      if (!IsPawn(piece))
+        continue;
+
+      Player color = GetPieceColor(piece);
+      bool white = color == Player::kWhite;
+      int sign = white ? 1 : -1;
+      board_coord forward = white ? 1 : -1;
+      board_coord relative_row = white ? row : kBoardSize - 1 - row;
+      Piece own_pawn = white ? Piece::kWhitePawn : Piece::kBlackPawn;
+      Piece enemy_pawn = white ? Piece::kBlackPawn : Piece::kWhitePawn;
+      int const *own_files = pawns_on_file[(uint8_t)color];
+
+      if (own_files[file] > 1)
+        entry.score -= sign * kDoubledPawnPenalty;
+
+      bool isolated = (file == 0 || own_files[file - 1] == 0) &&
+                      (file == kBoardSize - 1 || own_files[file + 1] == 0);
+      if (isolated) {
+        entry.score -= sign * kIsolatedPawnPenalty;
+      } else if (IsBackward(position, row, file, forward, own_pawn,
+                            enemy_pawn)) {
+        entry.score -= sign * kBackwardPawnPenalty;
+      }
+
+      if (IsPassed(position, row, file, forward, enemy_pawn)) {
+        entry.score += sign * kPassedPawnBonus[relative_row];
+        entry.passed_pawns |= uint64_t(1) << BoardIndex(row, file);
+      }
+    }
+  }
+
+  return entry;
+}
+
+// A zeroed entry is the correct entry for a board without pawns.
+PawnHashTable::PawnHashTable() : _entries(kPawnHashEntries) {}
+
+PawnEntry const &PawnHashTable::Probe(Position const &position) {
+  PawnEntry &entry = _entries[position.pawn_hash & (kPawnHashEntries - 1)];
+  if (entry.key != position.pawn_hash)
+    entry = EvaluatePawns(position);
+  return entry;
+}
\ No newline at end of file
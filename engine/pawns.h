@@ -0,0 +1,26 @@
+#pragma once
+
+#include "position.h"
+#include <stdint.h>
+#include <vector>
+
+struct PawnEntry {
+  uint64_t key;
+  // Pawn structure score in centipawns from white's point of view.
+  int score;
+  // One bit per square holding a passed pawn of either color.
+  uint64_t passed_pawns;
+};
+
+// Caches pawn structure evaluation by Position::pawn_hash. The pawns change
+// only on pawn moves and captures, so nearly every probe is a hit. Not thread
+// safe, each search thread owns its table.
+class PawnHashTable {
+public:
+  PawnHashTable();
+
+  PawnEntry const &Probe(Position const &position);
+
+private:
+  std::vector<PawnEntry> _entries;
+};
\ No newline at end of file
@@ -1,9 +1,42 @@
 #include "position.h"
 #include <array>
 #include <assert.h>
+#include <sstream>
 #include <stdint.h>
 #include <string>
 
+struct ZobristKeys {
+  // Keys of Piece::kNone stay zero so that empty squares hash to nothing.
+  uint64_t pieces[16][kBoardSquares];
+  uint64_t black_to_move;
+};
+
+static constexpr ZobristKeys MakeZobristKeys() {
+  ZobristKeys keys{};
+  uint64_t state = 0x9E3779B97F4A7C15;
+  auto next = [&state]() {
+    // splitmix64
+    uint64_t z = (state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  };
+
+  for (uint8_t piece = 1; piece < 16; piece++) {
+    for (uint8_t square = 0; square < kBoardSquares; square++) {
+      keys.pieces[piece][square] = next();
+    }
+  }
+  keys.black_to_move = next();
+  return keys;
+}
+
+static constexpr ZobristKeys kZobrist = MakeZobristKeys();
+
+static uint64_t PieceKey(Piece piece, board_index square) {
+  return kZobrist.pieces[(uint8_t)piece][square];
+}
+
 static uint8_t FromNotationSquare(char file, char row) {
   assert(file >= 'a');
   assert(file <= 'a' + kBoardSize);
@@ -39,7 +72,7 @@ Move GetMove(std::string const &str) {
     start_index = 1;
   }
 
-  Move move;
+  Move move{};
   move.from = FromNotationSquare(str[start_index + 0], str[start_index + 1]);
 
   if (str[start_index + 2] == 'x') {
@@ -134,14 +167,119 @@ Position GetStartingPosition() {
     position.board[kBoardSize * (kBoardSize - 2) + i] = Piece::kBlackPawn;
   }
 
+  ComputeHashes(position);
   return position;
 }
 
+static Piece FromFenPiece(char c) {
+  switch (c) {
+  case 'P':
+    return Piece::kWhitePawn;
+  case 'N':
+    return Piece::kWhiteKnight;
+  case 'B':
+    return Piece::kWhiteBishop;
+  case 'R':
+    return Piece::kWhiteRook;
+  case 'Q':
+    return Piece::kWhiteQueen;
+  case 'K':
+    return Piece::kWhiteKing;
+  case 'p':
+    return Piece::kBlackPawn;
+  case 'n':
+    return Piece::kBlackKnight;
+  case 'b':
+    return Piece::kBlackBishop;
+  case 'r':
+    return Piece::kBlackRook;
+  case 'q':
+    return Piece::kBlackQueen;
+  case 'k':
+    return Piece::kBlackKing;
+  default:
+    return Piece::kNone;
+  }
+}
+
+bool ParseFen(std::string const &fen, Position &position) {
+  std::istringstream stream(fen);
+  std::string placement, active_color;
+  if (!(stream >> placement >> active_color))
+    return false;
+
+  Position result = Position();
+  board_coord row = kBoardSize - 1;
+  board_coord file = 0;
+  for (char c : placement) {
+    if (c == '/') {
+      if (file != kBoardSize || row == 0)
+        return false;
+      row--;
+      file = 0;
+    } else if (c >= '1' && c <= '8') {
+      file += c - '0';
+      if (file > kBoardSize)
+        return false;
+    } else {
+      Piece piece = FromFenPiece(c);
+      if (piece == Piece::kNone || file >= kBoardSize)
+        return false;
+      result.board[BoardIndex(row, file)] = piece;
+      file++;
+    }
+  }
+  if (row != 0 || file != kBoardSize)
+    return false;
+
+  if (active_color == "w") {
+    result.active_player = Player::kWhite;
+  } else if (active_color == "b") {
+    result.active_player = Player::kBlack;
+  } else {
+    return false;
+  }
+
+  ComputeHashes(result);
+  position = result;
+  return true;
+}
+
+void ComputeHashes(Position &position) {
+  position.hash = 0;
+  position.pawn_hash = 0;
+  for (board_index i = 0; i < kBoardSquares; i++) {
+    Piece piece = position.board[i];
+    position.hash ^= PieceKey(piece, i);
+    if (IsPawn(piece))
+      position.pawn_hash ^= PieceKey(piece, i);
+  }
+  if (position.active_player == Player::kBlack)
+    position.hash ^= kZobrist.black_to_move;
+}
+
 void PlayMove(Position &position, Move move) {
-  position.board[move.to] =
-      static_cast<Piece>((uint8_t)position.board[move.from] + move.promotion);
+  Piece moving = position.board[move.from];
+  Piece captured = position.board[move.to];
+  Piece placed = static_cast<Piece>((uint8_t)moving + move.promotion);
+
+  position.hash ^= PieceKey(moving, move.from) ^ PieceKey(captured, move.to) ^
+                   PieceKey(placed, move.to) ^ kZobrist.black_to_move;
+  if (IsPawn(moving))
+    position.pawn_hash ^= PieceKey(moving, move.from);
+  if (IsPawn(captured))
+    position.pawn_hash ^= PieceKey(captured, move.to);
+  if (IsPawn(placed))
+    position.pawn_hash ^= PieceKey(placed, move.to);
+
+  position.board[move.to] = placed;
   position.board[move.from] = Piece::kNone;
   position.active_player = position.active_player == Player::kWhite
                                ? Player::kBlack
                                : Player::kWhite;
+}
+
+void PlayNullMove(Position &position) {
+  position.hash ^= kZobrist.black_to_move;
+  position.active_player = InverseColor(position.active_player);
 }
\ No newline at end of file
@@ -57,20 +57,24 @@ inline Piece BlackToWhite(Piece piece) {
 }
 
 inline Player GetPieceColor(Piece piece) {
-  return static_cast<Player>((uint8_t)piece / (uint8_t)Piece::kLastWhite);
+  return ((uint8_t)piece & kPieceColorBit) ? Player::kBlack : Player::kWhite;
+}
+
+inline bool IsPawn(Piece piece) {
+  return BlackToWhite(piece) == Piece::kWhitePawn;
 }
 
 inline int GetPieceValue(Piece piece) {
   switch (BlackToWhite(piece)) {
   case Piece::kWhitePawn:
-    return 1;
+    return 100;
   case Piece::kWhiteBishop:
   case Piece::kWhiteKnight:
-    return 3;
+    return 300;
   case Piece::kWhiteRook:
-    return 5;
+    return 500;
   case Piece::kWhiteQueen:
-    return 9;
+    return 900;
   default:
     return 0;
   }
@@ -82,9 +86,16 @@ struct Move {
   int8_t promotion;
 };
 
+inline bool IsNullMove(Move move) { return move.from == move.to; }
+
 struct Position {
   Player active_player;
   Piece board[kBoardSquares];
+  // Zobrist keys, maintained by PlayMove(). pawn_hash only covers the pawns.
+  uint64_t hash;
+  uint64_t pawn_hash;
+
+  bool operator==(Position const &) const = default;
 };
 
 inline board_index BoardIndex(board_coord row, board_coord file) {
@@ -95,4 +106,14 @@ Move GetMove(std::string const &str);
 std::string ToNotation(Position const &position, Move move);
 
 Position GetStartingPosition();
-void PlayMove(Position &position, Move move);
\ No newline at end of file
+// Reads the piece placement and the active color of a FEN or EPD record.
+// Castling and en passant fields are ignored.
+bool ParseFen(std::string const &fen, Position &position);
+// Recomputes the Zobrist keys from the board.
+void ComputeHashes(Position &position);
+// Identifies the Zobrist keys in saved hash tables. Bump it whenever the keys
+// change.
+constexpr uint32_t kHashKeyVersion = 1;
+void PlayMove(Position &position, Move move);
+// Passes the turn to the other player.
+void PlayNullMove(Position &position);
\ No newline at end of file
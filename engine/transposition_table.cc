@@ -0,0 +1,267 @@
+#include "transposition_table.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "advapi32.lib")
+#else
+#include <sys/mman.h>
+#endif
+
+static constexpr size_t kHugePageSize = 2 << 20;
+
+// Below this, starting the threads costs more than the clearing.
+static constexpr size_t kParallelClearBytes = 64 << 20;
+
+char const *GetPageModeName(PageMode mode) {
+  switch (mode) {
+  case PageMode::kTransparentHugePages:
+    return "transparent huge pages";
+  case PageMode::kLargePages:
+    return "large pages";
+  default:
+    return "normal pages";
+  }
+}
+
+#ifdef MADV_HUGEPAGE
+// madvise(MADV_HUGEPAGE) succeeds even when transparent huge pages are
+// disabled, so ask the kernel whether they are actually in use. The active
+// setting is the one in brackets, e.g. "always [madvise] never".
+static bool TransparentHugePagesEnabled() {
+  std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string setting;
+  if (!std::getline(file, setting))
+    return false;
+  return setting.find("[never]") == std::string::npos;
+}
+#endif
+
+#ifdef _WIN32
+// Large pages need the "Lock pages in memory" privilege, which is usually not
+// granted, and even when it is, it has to be enabled in the process token.
+static bool EnableLockMemoryPrivilege() {
+  HANDLE token;
+  if (!OpenProcessToken(GetCurrentProcess(),
+                        TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+    return false;
+  }
+
+  TOKEN_PRIVILEGES privileges{};
+  privileges.PrivilegeCount = 1;
+  privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+  bool enabled =
+      LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege",
+                            &privileges.Privileges[0].Luid) &&
+      AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+      // Succeeds without enabling anything if the privilege isn't granted.
+      GetLastError() == ERROR_SUCCESS;
+  CloseHandle(token);
+  return enabled;
+}
+#endif
+
+// Returns nullptr on failure.
+static void *Allocate(size_t bytes, PageMode &mode) {
+#ifdef _WIN32
+  size_t large_page = GetLargePageMinimum();
+  if (large_page > 0 && bytes % large_page == 0 &&
+      EnableLockMemoryPrivilege()) {
+    void *memory =
+        VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                     PAGE_READWRITE);
+    if (memory != nullptr) {
+      mode = PageMode::kLargePages;
+      return memory;
+    }
+  }
+
+  mode = PageMode::kNormal;
+  return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT,
+                      PAGE_READWRITE);
+#else
+#ifdef MAP_HUGETLB
+  // Only succeeds if huge pages have been reserved by the administrator.
+  void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (memory != MAP_FAILED) {
+    mode = PageMode::kLargePages;
+    return memory;
+  }
+#endif
+
+  void *aligned = nullptr;
+  if (posix_memalign(&aligned, kHugePageSize, bytes) != 0)
+    return nullptr;
+
+  mode = PageMode::kNormal;
+#ifdef MADV_HUGEPAGE
+  if (madvise(aligned, bytes, MADV_HUGEPAGE) == 0 &&
+      TransparentHugePagesEnabled()) {
+    mode = PageMode::kTransparentHugePages;
+  }
+#endif
+  return aligned;
+#endif
+}
+
+static void Deallocate(void *memory, size_t bytes, PageMode mode) {
+#ifdef _WIN32
+  (void)bytes;
+  (void)mode;
+  VirtualFree(memory, 0, MEM_RELEASE);
+#else
+  if (mode == PageMode::kLargePages) {
+    munmap(memory, bytes);
+  } else {
+    free(memory);
+  }
+#endif
+}
+
+TranspositionTable::~TranspositionTable() { Free(); }
+
+void TranspositionTable::Free() {
+  if (_entries != nullptr)
+    Deallocate(_entries, _allocated_bytes, _page_mode);
+  _entries = nullptr;
+  _count = 0;
+  _allocated_bytes = 0;
+  _page_mode = PageMode::kNormal;
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+  Free();
+
+  // A power of two number of entries, so that the key can be masked.
+  size_t bytes = std::bit_floor(std::max<size_t>(megabytes, 1) << 20);
+  _allocated_bytes = std::max(bytes, kHugePageSize);
+  _entries = static_cast<TTEntry *>(Allocate(_allocated_bytes, _page_mode));
+  if (_entries == nullptr) {
+    _allocated_bytes = 0;
+    return;
+  }
+  _count = bytes / sizeof(TTEntry);
+
+  Clear();
+}
+
+void TranspositionTable::Clear() {
+  size_t bytes = _count * sizeof(TTEntry);
+  size_t threads = 1;
+  if (bytes >= kParallelClearBytes)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // The engine searches with a single thread, so the clearing threads stand
+  // in for the threads that will be probing the table.
+  std::vector<std::thread> workers;
+  size_t chunk = (_count + threads - 1) / threads;
+  for (size_t i = 0; i < threads; i++) {
+    size_t begin = std::min(i * chunk, _count);
+    size_t end = std::min(begin + chunk, _count);
+    workers.emplace_back([this, begin, end]() {
+      std::memset(_entries + begin, 0, (end - begin) * sizeof(TTEntry));
+    });
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+static constexpr char kSnapshotMagic[8] = {'C', 'H', 'E', 'S',
+                                           'S', 'A', 'T', 'T'};
+
+// Padded so that the entries that follow stay aligned.
+struct alignas(64) SnapshotHeader {
+  char magic[8];
+  uint32_t key_version;
+  uint32_t entry_size;
+  uint64_t entry_count;
+};
+
+bool TranspositionTable::Save(std::string const &path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+    return false;
+
+  SnapshotHeader header{};
+  std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+  header.key_version = kHashKeyVersion;
+  header.entry_size = sizeof(TTEntry);
+  header.entry_count = _count;
+
+  file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+  file.write(reinterpret_cast<char const *>(_entries),
+             _count * sizeof(TTEntry));
+  return (bool)file.flush();
+}
+
+bool TranspositionTable::Load(std::string const &path) {
+  MappedFile file;
+  if (!file.Open(path) || file.GetSize() < sizeof(SnapshotHeader))
+    return false;
+
+  SnapshotHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+      header.key_version != kHashKeyVersion ||
+      header.entry_size != sizeof(TTEntry) ||
+      header.entry_count >
+          (file.GetSize() - sizeof(header)) / sizeof(TTEntry)) {
+    return false;
+  }
+
+  TTEntry const *entries = reinterpret_cast<TTEntry const *>(
+      static_cast<char const *>(file.GetData()) + sizeof(header));
+  if (header.entry_count == _count) {
+    std::memcpy(_entries, entries, _count * sizeof(TTEntry));
+    return true;
+  }
+
+  Clear();
+  for (size_t i = 0; i < header.entry_count; i++) {
+    TTEntry const &entry = entries[i];
+    if (entry.bound != Bound::kNone)
+      Store(entry.key, entry.move, entry.score, entry.depth, entry.bound);
+  }
+  return true;
+}
+
+TTEntry const *TranspositionTable::Probe(uint64_t key) const {
+  if (_count == 0)
+    return nullptr;
+
+  TTEntry const &entry = _entries[key & (_count - 1)];
+  if (entry.key != key || entry.bound == Bound::kNone)
+    return nullptr;
+  return &entry;
+}
+
+void TranspositionTable::Store(uint64_t key, Move move, int score, int depth,
+                               Bound bound) {
+  if (_count == 0)
+    return;
+
+  TTEntry &entry = _entries[key & (_count - 1)];
+  // Keep deeper results of the same position, unless this one is exact.
+  if (entry.key == key && entry.depth > depth && bound != Bound::kExact)
+    return;
+
+  // Keep the old move if this search did not find one.
+  if (IsNullMove(move) && entry.key == key)
+    move = entry.move;
+
+  entry.key = key;
+  entry.score = (int16_t)score;
+  entry.move = move;
+  entry.depth = (int8_t)depth;
+  entry.bound = bound;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "position.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+enum class Bound : uint8_t { kNone, kExact, kLower, kUpper };
+
+struct TTEntry {
+  uint64_t key;
+  int16_t score;
+  Move move;
+  int8_t depth;
+  Bound bound;
+};
+
+static_assert(sizeof(TTEntry) == 16);
+
+// How the table memory is backed.
+enum class PageMode {
+  kNormal,
+  // Transparent huge pages requested with madvise().
+  kTransparentHugePages,
+  // Explicit huge pages from mmap(MAP_HUGETLB) or VirtualAlloc().
+  kLargePages,
+};
+
+char const *GetPageModeName(PageMode mode);
+
+// Fixed size hash table of search results indexed by Position::hash. Large
+// tables are probed at random, so they are backed by huge pages where
+// possible to keep the TLB misses down.
+class TranspositionTable {
+public:
+  TranspositionTable() = default;
+  TranspositionTable(TranspositionTable const &) = delete;
+  TranspositionTable &operator=(TranspositionTable const &) = delete;
+  ~TranspositionTable();
+
+  void Resize(size_t megabytes);
+  // Zeroes the table. Large tables are cleared by several threads so that,
+  // with first touch placement, the pages are spread over the NUMA nodes.
+  void Clear();
+
+  // Snapshots keep the table layout, so that loading one is a copy from a
+  // memory mapped file. A snapshot of another size is rehashed on load.
+  bool Save(std::string const &path) const;
+  bool Load(std::string const &path);
+
+  TTEntry const *Probe(uint64_t key) const;
+  void Store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+  size_t GetSizeBytes() const { return _count * sizeof(TTEntry); }
+  PageMode GetPageMode() const { return _page_mode; }
+
+private:
+  void Free();
+
+  TTEntry *_entries = nullptr;
+  size_t _count = 0;
+  size_t _allocated_bytes = 0;
+  PageMode _page_mode = PageMode::kNormal;
+};
\ No newline at end of file
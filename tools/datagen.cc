@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/engine.h"
+#include "engine/position.h"
+#include "tools/flags.h"
+#include "tools/game.h"
+#include "tools/packed_position.h"
+#include "tools/training_data.h"
+
+// Generates evaluation training data with fixed depth self-play. Every quiet
+// position of a game is written as a PackedPosition once the game result is
+// known.
+//
+// Usage: datagen --output=<file> [--openings=<epd file>] [--games=N]
+//                [--concurrency=N] [--depth=N] [--random-plies=N]
+//                [--seed=N] [--buffer-mb=N] [--direct-io=0|1]
+
+struct Options : GameFlags {
+  std::string output;
+  int depth = 4;
+  // Random moves played from the opening so that the games differ.
+  int random_plies = 8;
+  uint64_t seed = 0;
+  size_t buffer_bytes = 16 << 20;
+  bool direct_io = true;
+};
+
+static bool ParseOptions(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    int number = 0;
+
+    FlagResult game_flag = ParseGameFlag(arg, options);
+    if (game_flag != FlagResult::kNotMatched) {
+      valid = game_flag == FlagResult::kParsed;
+    } else if (ParseFlag(arg, "output", value)) {
+      options.output = value;
+    } else if (ParseFlag(arg, "depth", value)) {
+      valid = ParseNumber(arg, value, number);
+      options.depth = std::max(1, number);
+    } else if (ParseFlag(arg, "random-plies", value)) {
+      valid = ParseNumber(arg, value, options.random_plies);
+    } else if (ParseFlag(arg, "seed", value)) {
+      valid = ParseNumber(arg, value, options.seed);
+    } else if (ParseFlag(arg, "buffer-mb", value)) {
+      valid = ParseNumber(arg, value, number);
+      options.buffer_bytes = (size_t)std::max(1, number) << 20;
+    } else if (ParseFlag(arg, "direct-io", value)) {
+      valid = ParseNumber(arg, value, number);
+      options.direct_io = number != 0;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return false;
+    }
+
+    if (!valid)
+      return false;
+  }
+
+  if (options.output.empty()) {
+    std::cerr << "--output is required" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Plays random legal moves. Fails if the game ended on the way.
+static bool PlayRandomPlies(Position &position, int plies,
+                            std::mt19937_64 &rng) {
+  for (int i = 0; i < plies; i++) {
+    std::vector<Move> moves = GetLegalMoves(position);
+    if (moves.empty())
+      return false;
+    PlayMove(position, moves[rng() % moves.size()]);
+  }
+  return !GetLegalMoves(position).empty();
+}
+
+// Positions where the static evaluation is not meant to match the search.
+static bool IsNoisy(Position const &position, Move move,
+                    SearchInfo const &info) {
+  return info.mate != 0 || IsInCheck(position) ||
+         position.board[move.to] != Piece::kNone || move.promotion != 0;
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options))
+    return 1;
+
+  std::vector<Position> openings;
+  if (options.openings.empty()) {
+    openings.push_back(GetStartingPosition());
+  } else if (!LoadOpenings(options.openings, openings) || openings.empty()) {
+    std::cerr << "Could not read openings from " << options.openings
+              << std::endl;
+    return 1;
+  }
+
+  TrainingDataWriter writer;
+  if (!writer.Open(options.output, options.buffer_bytes, options.direct_io)) {
+    std::cerr << "Could not open " << options.output << std::endl;
+    return 1;
+  }
+  std::printf("Writing to %s with %s I/O\n", options.output.c_str(),
+              writer.IsDirectIO() ? "direct" : "buffered");
+
+  SearchLimits limits;
+  limits.depth = options.depth;
+
+  std::mutex mutex;
+  bool write_failed = false;
+  uint64_t positions = 0;
+  int games_done = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  std::atomic<int> next_game = 0;
+
+  auto worker = [&]() {
+    auto white = std::make_unique<Engine>();
+    auto black = std::make_unique<Engine>();
+    std::vector<PackedPosition> records;
+
+    while (true) {
+      int game = next_game++;
+      if (game >= options.games)
+        return;
+
+      // Seeded by game so that runs are reproducible.
+      std::mt19937_64 rng(options.seed * 0x9E3779B97F4A7C15 + game);
+      Position start = openings[game % openings.size()];
+      if (!PlayRandomPlies(start, options.random_plies, rng))
+        continue;
+
+      // Otherwise the results would depend on the earlier games of the thread.
+      white->NewGame();
+      black->NewGame();
+      records.clear();
+      GameResult result = PlayGame(
+          start, *white, limits, *black, limits,
+          [&records](Position const &position, Move move,
+                     SearchInfo const &info) {
+            PackedPosition record;
+            if (!IsNoisy(position, move, info) &&
+                PackPosition(position, move, info.score_cp, record)) {
+              records.push_back(record);
+            }
+          });
+
+      int8_t white_result = result == GameResult::kWhiteWin   ? 1
+                            : result == GameResult::kBlackWin ? -1
+                                                              : 0;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (PackedPosition &record : records) {
+        record.result = white_result;
+        write_failed = !writer.Write(record) || write_failed;
+      }
+      positions += records.size();
+      games_done++;
+
+      if (games_done % 100 == 0) {
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start_time)
+                             .count();
+        std::printf("Games: %d Positions: %llu (%.0f/s)\n", games_done,
+                    (unsigned long long)positions, positions / seconds);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < options.concurrency; i++)
+    threads.emplace_back(worker);
+  for (std::thread &thread : threads)
+    thread.join();
+
+  if (!writer.Close() || write_failed) {
+    std::cerr << "Writing " << options.output << " failed" << std::endl;
+    return 1;
+  }
+  std::printf("Done. Games: %d Positions: %llu\n", games_done,
+              (unsigned long long)positions);
+  return 0;
+}
\ No newline at end of file
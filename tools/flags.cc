@@ -0,0 +1,58 @@
+#include "flags.h"
+#include <charconv>
+#include <iostream>
+
+bool ParseFlag(std::string const &arg, std::string const &name,
+               std::string &value) {
+  std::string prefix = "--" + name + "=";
+  if (arg.rfind(prefix, 0) != 0)
+    return false;
+  value = arg.substr(prefix.size());
+  return true;
+}
+
+template <typename T>
+static bool ParseNumberImpl(std::string const &arg, std::string const &value,
+                            T &number) {
+  char const *end = value.data() + value.size();
+  auto [ptr, error] = std::from_chars(value.data(), end, number);
+  if (error != std::errc() || ptr != end) {
+    std::cerr << "Invalid number: " << arg << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ParseNumber(std::string const &arg, std::string const &value,
+                 int &number) {
+  return ParseNumberImpl(arg, value, number);
+}
+
+bool ParseNumber(std::string const &arg, std::string const &value,
+                 uint64_t &number) {
+  return ParseNumberImpl(arg, value, number);
+}
+
+bool ParseNumber(std::string const &arg, std::string const &value,
+                 double &number) {
+  return ParseNumberImpl(arg, value, number);
+}
+
+FlagResult ParseGameFlag(std::string const &arg, GameFlags &flags) {
+  std::string value;
+  bool valid;
+
+  if (ParseFlag(arg, "openings", value)) {
+    flags.openings = value;
+    valid = true;
+  } else if (ParseFlag(arg, "games", value)) {
+    valid = ParseNumber(arg, value, flags.games);
+  } else if (ParseFlag(arg, "concurrency", value)) {
+    valid = ParseNumber(arg, value, flags.concurrency);
+    flags.concurrency = std::max(1, flags.concurrency);
+  } else {
+    return FlagResult::kNotMatched;
+  }
+
+  return valid ? FlagResult::kParsed : FlagResult::kInvalid;
+}
\ No newline at end of file
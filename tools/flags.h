@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+// Flags of the tools that play games in parallel.
+struct GameFlags {
+  std::string openings;
+  int games = 1000;
+  int concurrency = std::max(1u, std::thread::hardware_concurrency());
+};
+
+enum class FlagResult { kNotMatched, kParsed, kInvalid };
+
+// Matches "--<name>=<value>" and extracts the value.
+bool ParseFlag(std::string const &arg, std::string const &name,
+               std::string &value);
+
+// The whole value must be a number. Prints an error for the flag arg if it
+// isn't.
+bool ParseNumber(std::string const &arg, std::string const &value,
+                 int &number);
+bool ParseNumber(std::string const &arg, std::string const &value,
+                 uint64_t &number);
+bool ParseNumber(std::string const &arg, std::string const &value,
+                 double &number);
+
+// Parses --openings, --games and --concurrency.
+FlagResult ParseGameFlag(std::string const &arg, GameFlags &flags);
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "game.h"
+#include <algorithm>
+#include <fstream>
+
+static constexpr size_t kMaxGamePlies = 400;
+static constexpr int kFiftyMovePlies = 100;
+
+static bool IsInsufficientMaterial(Position const &position) {
+  int minor_pieces = 0;
+  for (Piece piece : position.board) {
+    switch (BlackToWhite(piece)) {
+    case Piece::kNone:
+    case Piece::kWhiteKing:
+      break;
+    case Piece::kWhiteKnight:
+    case Piece::kWhiteBishop:
+      minor_pieces++;
+      break;
+    default:
+      return false;
+    }
+  }
+  return minor_pieces <= 1;
+}
+
+GameResult PlayGame(Position const &start, Engine &white,
+                    SearchLimits const &white_limits, Engine &black,
+                    SearchLimits const &black_limits,
+                    MoveCallback on_move) {
+  Position position = start;
+  // Positions since the last irreversible move, for repetition detection.
+  std::vector<Position> history{position};
+  int reversible_plies = 0;
+  size_t plies = 0;
+
+  while (true) {
+    if (GetLegalMoves(position).empty()) {
+      if (!IsInCheck(position))
+        return GameResult::kDraw;
+      return position.active_player == Player::kWhite ? GameResult::kBlackWin
+                                                      : GameResult::kWhiteWin;
+    }
+
+    if (reversible_plies >= kFiftyMovePlies || plies >= kMaxGamePlies ||
+        IsInsufficientMaterial(position) ||
+        std::count(history.begin(), history.end(), position) >= 3) {
+      return GameResult::kDraw;
+    }
+
+    bool white_to_move = position.active_player == Player::kWhite;
+    Engine &engine = white_to_move ? white : black;
+    engine.EnterPosition(position);
+    SearchInfo info{};
+    engine.StartSearch(white_to_move ? white_limits : black_limits, nullptr,
+                       [&info](SearchInfo const &update) { info = update; });
+    Move move = engine.GetBestMove();
+    if (on_move)
+      on_move(position, move, info);
+
+    bool irreversible =
+        position.board[move.to] != Piece::kNone ||
+        BlackToWhite(position.board[move.from]) == Piece::kWhitePawn;
+    PlayMove(position, move);
+    plies++;
+
+    if (irreversible) {
+      history.clear();
+      reversible_plies = 0;
+    } else {
+      reversible_plies++;
+    }
+    history.push_back(position);
+  }
+}
+
+bool LoadOpenings(std::string const &path, std::vector<Position> &openings) {
+  std::ifstream file(path);
+  if (!file)
+    return false;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    Position position;
+    if (!ParseFen(line, position))
+      return false;
+    openings.push_back(position);
+  }
+
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "engine/engine.h"
+#include "engine/position.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class GameResult { kWhiteWin, kDraw, kBlackWin };
+
+// Called before each move is played with the last completed search
+// iteration that chose it.
+using MoveCallback = std::function<void(
+    Position const &position, Move move, SearchInfo const &info)>;
+
+// Plays a game between two engines until it is decided. Long games are
+// adjudicated as draws.
+GameResult PlayGame(Position const &start, Engine &white,
+                    SearchLimits const &white_limits, Engine &black,
+                    SearchLimits const &black_limits,
+                    MoveCallback on_move = nullptr);
+
+// Reads one position per line from an EPD or FEN file.
+bool LoadOpenings(std::string const &path, std::vector<Position> &openings);
\ No newline at end of file
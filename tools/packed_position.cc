@@ -0,0 +1,58 @@
+#include "packed_position.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+bool PackPosition(Position const &position, Move move, int score,
+                  PackedPosition &packed) {
+  packed = PackedPosition();
+
+  int count = 0;
+  for (board_index i = 0; i < kBoardSquares; i++) {
+    Piece piece = position.board[i];
+    if (piece == Piece::kNone)
+      continue;
+
+    if (count >= 32)
+      return false;
+    packed.occupancy |= uint64_t(1) << i;
+    packed.pieces[count / 2] |= (uint8_t)piece << (count % 2 * 4);
+    count++;
+  }
+
+  packed.score = (int16_t)std::clamp<int>(
+      score, std::numeric_limits<int16_t>::min(),
+      std::numeric_limits<int16_t>::max());
+  packed.move = (uint16_t)(move.from | move.to << 6 | move.promotion << 12);
+  packed.active_player = position.active_player;
+  return true;
+}
+
+bool UnpackPosition(PackedPosition const &packed, Position &position,
+                    Move &move) {
+  if (std::popcount(packed.occupancy) > 32 ||
+      packed.active_player > Player::kBlack) {
+    return false;
+  }
+
+  Position result = Position();
+  int count = 0;
+  for (uint64_t squares = packed.occupancy; squares != 0;
+       squares &= squares - 1) {
+    board_index square = std::countr_zero(squares);
+    Piece piece =
+        static_cast<Piece>(packed.pieces[count / 2] >> (count % 2 * 4) & 0xF);
+    if (!IsWhitePiece(piece) && !IsBlackPiece(piece))
+      return false;
+    result.board[square] = piece;
+    count++;
+  }
+  result.active_player = packed.active_player;
+  ComputeHashes(result);
+
+  position = result;
+  move.from = packed.move & 0x3F;
+  move.to = packed.move >> 6 & 0x3F;
+  move.promotion = packed.move >> 12 & 0xF;
+  return true;
+}
\ No newline at end of file
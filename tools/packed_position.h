@@ -0,0 +1,29 @@
+#pragma once
+
+#include "engine/position.h"
+#include <stdint.h>
+
+// Compact training record. The pieces of the squares set in occupancy are
+// stored in square order, one Piece per nibble. A legal position has at most
+// 32 pieces, which is all that fits.
+struct PackedPosition {
+  uint64_t occupancy;
+  uint8_t pieces[16];
+  // Search score in centipawns from the side to move's point of view.
+  int16_t score;
+  // Best move as from | to << 6 | promotion << 12.
+  uint16_t move;
+  Player active_player;
+  // Game result from white's point of view: 1 win, 0 draw, -1 loss.
+  int8_t result;
+  uint8_t reserved[2];
+};
+
+static_assert(sizeof(PackedPosition) == 32);
+
+// Fails if the position has more pieces than fit.
+bool PackPosition(Position const &position, Move move, int score,
+                  PackedPosition &packed);
+// Fails if the record does not describe a board.
+bool UnpackPosition(PackedPosition const &packed, Position &position,
+                    Move &move);
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/engine.h"
+#include "engine/position.h"
+#include "tools/flags.h"
+#include "tools/game.h"
+
+// Plays games between two engine configurations and tells whether the first
+// one is stronger, using a sequential probability ratio test.
+//
+// Usage: selfplay [--openings=<epd file>] [--games=N] [--concurrency=N]
+//                 [--movetime=ms] [--movetime1=ms] [--movetime2=ms]
+//                 [--depth1=N] [--depth2=N]
+//                 [--option1=Name=value]... [--option2=Name=value]...
+//                 [--elo0=0] [--elo1=5] [--alpha=0.05] [--beta=0.05]
+
+struct Options : GameFlags {
+  SearchLimits limits[2];
+  // Engine options of each configuration, see kSearchOptions.
+  std::vector<std::pair<std::string, std::string>> engine_options[2];
+  double elo0 = 0;
+  double elo1 = 5;
+  double alpha = 0.05;
+  double beta = 0.05;
+};
+
+struct Stats {
+  // From the point of view of the first configuration.
+  int wins = 0;
+  int draws = 0;
+  int losses = 0;
+
+  int Games() const { return wins + draws + losses; }
+  double Score() const { return (wins + draws / 2.0) / Games(); }
+  // Variance of a single game result.
+  double Variance() const {
+    double m = Score();
+    return (wins * (1 - m) * (1 - m) + draws * (0.5 - m) * (0.5 - m) +
+            losses * m * m) /
+           Games();
+  }
+};
+
+static double ScoreToElo(double score) {
+  return -400 * std::log10(1 / score - 1);
+}
+
+static double EloToScore(double elo) {
+  return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// Log-likelihood ratio of elo1 against elo0 under a normal approximation of
+// the game results.
+static double LogLikelihoodRatio(Stats const &stats, double elo0,
+                                 double elo1) {
+  double variance = stats.Variance();
+  if (variance <= 0)
+    return 0;
+
+  double s0 = EloToScore(elo0);
+  double s1 = EloToScore(elo1);
+  return stats.Games() * (s1 - s0) * (2 * stats.Score() - s0 - s1) /
+         (2 * variance);
+}
+
+static void PrintStats(Stats const &stats, Options const &options) {
+  double score = stats.Score();
+  double margin = 1.96 * std::sqrt(stats.Variance() / stats.Games());
+  double low = std::clamp(score - margin, 1e-6, 1 - 1e-6);
+  double high = std::clamp(score + margin, 1e-6, 1 - 1e-6);
+  double elo = ScoreToElo(std::clamp(score, 1e-6, 1 - 1e-6));
+  double error = (ScoreToElo(high) - ScoreToElo(low)) / 2;
+
+  double llr = LogLikelihoodRatio(stats, options.elo0, options.elo1);
+  double lower = std::log(options.beta / (1 - options.alpha));
+  double upper = std::log((1 - options.beta) / options.alpha);
+
+  std::printf("Games: %d W: %d D: %d L: %d Elo: %.1f +- %.1f "
+              "LLR: %.2f (%.2f, %.2f)\n",
+              stats.Games(), stats.wins, stats.draws, stats.losses, elo,
+              error, llr, lower, upper);
+}
+
+static bool ParseOptions(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string value;
+    bool valid = true;
+    int milliseconds = 0;
+
+    FlagResult game_flag = ParseGameFlag(arg, options);
+    if (game_flag != FlagResult::kNotMatched) {
+      valid = game_flag == FlagResult::kParsed;
+    } else if (ParseFlag(arg, "movetime", value)) {
+      valid = ParseNumber(arg, value, milliseconds);
+      options.limits[0].move_time = std::chrono::milliseconds(milliseconds);
+      options.limits[1].move_time = options.limits[0].move_time;
+    } else if (ParseFlag(arg, "movetime1", value)) {
+      valid = ParseNumber(arg, value, milliseconds);
+      options.limits[0].move_time = std::chrono::milliseconds(milliseconds);
+    } else if (ParseFlag(arg, "movetime2", value)) {
+      valid = ParseNumber(arg, value, milliseconds);
+      options.limits[1].move_time = std::chrono::milliseconds(milliseconds);
+    } else if (ParseFlag(arg, "depth1", value)) {
+      valid = ParseNumber(arg, value, options.limits[0].depth);
+    } else if (ParseFlag(arg, "depth2", value)) {
+      valid = ParseNumber(arg, value, options.limits[1].depth);
+    } else if (ParseFlag(arg, "option1", value) ||
+               ParseFlag(arg, "option2", value)) {
+      size_t separator = value.find('=');
+      if (separator == std::string::npos) {
+        std::cerr << "Expected Name=value: " << arg << std::endl;
+        return false;
+      }
+      int config = arg.rfind("--option1", 0) == 0 ? 0 : 1;
+      options.engine_options[config].emplace_back(
+          value.substr(0, separator), value.substr(separator + 1));
+    } else if (ParseFlag(arg, "elo0", value)) {
+      valid = ParseNumber(arg, value, options.elo0);
+    } else if (ParseFlag(arg, "elo1", value)) {
+      valid = ParseNumber(arg, value, options.elo1);
+    } else if (ParseFlag(arg, "alpha", value)) {
+      valid = ParseNumber(arg, value, options.alpha);
+    } else if (ParseFlag(arg, "beta", value)) {
+      valid = ParseNumber(arg, value, options.beta);
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return false;
+    }
+
+    if (!valid)
+      return false;
+  }
+
+  // Searches must end on their own.
+  for (SearchLimits &limits : options.limits) {
+    if (limits.depth == 0 && limits.move_time.count() == 0)
+      limits.move_time = std::chrono::milliseconds(100);
+  }
+
+  return true;
+}
+
+static bool ConfigureEngine(
+    Engine &engine,
+    std::vector<std::pair<std::string, std::string>> const &engine_options) {
+  for (auto const &[name, value] : engine_options) {
+    if (!engine.SetOption(name, value)) {
+      std::cerr << "Unknown engine option or invalid value: " << name << "="
+                << value << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options))
+    return 1;
+
+  {
+    Engine engine;
+    if (!ConfigureEngine(engine, options.engine_options[0]) ||
+        !ConfigureEngine(engine, options.engine_options[1])) {
+      return 1;
+    }
+  }
+
+  std::vector<Position> openings;
+  if (options.openings.empty()) {
+    openings.push_back(GetStartingPosition());
+  } else if (!LoadOpenings(options.openings, openings) || openings.empty()) {
+    std::cerr << "Could not read openings from " << options.openings
+              << std::endl;
+    return 1;
+  }
+
+  double lower = std::log(options.beta / (1 - options.alpha));
+  double upper = std::log((1 - options.beta) / options.alpha);
+
+  std::mutex mutex;
+  Stats stats;
+  std::atomic<int> next_game = 0;
+  std::atomic<bool> done = false;
+
+  auto worker = [&]() {
+    while (!done) {
+      int game = next_game++;
+      if (game >= options.games)
+        return;
+
+      // Both configurations play each opening once with either color.
+      Position const &opening = openings[(game / 2) % openings.size()];
+      bool first_is_white = game % 2 == 0;
+
+      auto first = std::make_unique<Engine>();
+      auto second = std::make_unique<Engine>();
+      ConfigureEngine(*first, options.engine_options[0]);
+      ConfigureEngine(*second, options.engine_options[1]);
+      GameResult result =
+          first_is_white
+              ? PlayGame(opening, *first, options.limits[0], *second,
+                         options.limits[1])
+              : PlayGame(opening, *second, options.limits[1], *first,
+                         options.limits[0]);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (result == GameResult::kDraw) {
+        stats.draws++;
+      } else if ((result == GameResult::kWhiteWin) == first_is_white) {
+        stats.wins++;
+      } else {
+        stats.losses++;
+      }
+      PrintStats(stats, options);
+
+      double llr = LogLikelihoodRatio(stats, options.elo0, options.elo1);
+      if (llr <= lower || llr >= upper)
+        done = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < options.concurrency; i++)
+    threads.emplace_back(worker);
+  for (std::thread &thread : threads)
+    thread.join();
+
+  double llr = LogLikelihoodRatio(stats, options.elo0, options.elo1);
+  if (llr >= upper) {
+    std::printf("SPRT: H1 accepted, elo >= %.1f\n", options.elo1);
+  } else if (llr <= lower) {
+    std::printf("SPRT: H0 accepted, elo <= %.1f\n", options.elo0);
+  } else {
+    std::printf("SPRT: inconclusive\n");
+  }
+
+  return 0;
+}
\ No newline at end of file
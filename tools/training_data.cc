@@ -0,0 +1,136 @@
+#include "training_data.h"
+#include <algorithm>
+#include <new>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Direct I/O needs the buffer, the file offset and the write size aligned.
+static constexpr size_t kDirectIOAlignment = 4096;
+static constexpr size_t kRecordsPerBlock =
+    kDirectIOAlignment / sizeof(PackedPosition);
+
+static int OpenForWriting(std::string const &path, bool direct_io) {
+#ifdef _WIN32
+  (void)direct_io;
+  return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+               _S_IREAD | _S_IWRITE);
+#else
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+  if (direct_io)
+    flags |= O_DIRECT;
+#else
+  (void)direct_io;
+#endif
+  return open(path.c_str(), flags, 0644);
+#endif
+}
+
+static bool WriteAll(int fd, void const *data, size_t bytes) {
+  char const *cursor = static_cast<char const *>(data);
+  while (bytes > 0) {
+#ifdef _WIN32
+    int written =
+        _write(fd, cursor, (unsigned)std::min<size_t>(bytes, 1 << 30));
+#else
+    ssize_t written = write(fd, cursor, bytes);
+#endif
+    if (written <= 0)
+      return false;
+    cursor += written;
+    bytes -= written;
+  }
+  return true;
+}
+
+TrainingDataWriter::~TrainingDataWriter() { Close(); }
+
+bool TrainingDataWriter::Open(std::string const &path, size_t buffer_bytes,
+                              bool direct_io) {
+  Close();
+
+#ifdef O_DIRECT
+  _direct_io = direct_io;
+#else
+  _direct_io = false;
+#endif
+  _fd = OpenForWriting(path, _direct_io);
+  if (_fd < 0 && _direct_io) {
+    // Some file systems, like tmpfs, refuse direct I/O.
+    _direct_io = false;
+    _fd = OpenForWriting(path, false);
+  }
+  if (_fd < 0)
+    return false;
+
+  size_t records = std::max<size_t>(buffer_bytes / sizeof(PackedPosition), 1);
+  _capacity = (records + kRecordsPerBlock - 1) / kRecordsPerBlock *
+              kRecordsPerBlock;
+  _buffer = static_cast<PackedPosition *>(
+      operator new(_capacity * sizeof(PackedPosition),
+                   std::align_val_t(kDirectIOAlignment)));
+  _size = 0;
+  return true;
+}
+
+bool TrainingDataWriter::Write(PackedPosition const &record) {
+  _buffer[_size++] = record;
+  if (_size == _capacity)
+    return Flush();
+  return true;
+}
+
+bool TrainingDataWriter::Flush() {
+  bool ok = WriteAll(_fd, _buffer, _size * sizeof(PackedPosition));
+  _size = 0;
+  return ok;
+}
+
+bool TrainingDataWriter::Close() {
+  if (_fd < 0)
+    return true;
+
+  bool ok = true;
+#ifdef O_DIRECT
+  // The tail is not a whole number of blocks, write it through the cache.
+  if (_direct_io && _size % kRecordsPerBlock != 0)
+    ok = fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) & ~O_DIRECT) == 0;
+#endif
+  ok = ok && Flush();
+
+#ifdef _WIN32
+  ok = _close(_fd) == 0 && ok;
+#else
+  ok = close(_fd) == 0 && ok;
+#endif
+  _fd = -1;
+
+  operator delete(_buffer, std::align_val_t(kDirectIOAlignment));
+  _buffer = nullptr;
+  _capacity = 0;
+  _size = 0;
+  return ok;
+}
+
+bool TrainingDataReader::Open(std::string const &path) {
+  Close();
+  if (!_file.Open(path))
+    return false;
+
+  _records = std::span<PackedPosition const>(
+      static_cast<PackedPosition const *>(_file.GetData()),
+      _file.GetSize() / sizeof(PackedPosition));
+  return true;
+}
+
+void TrainingDataReader::Close() {
+  _records = {};
+  _file.Close();
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "engine/mapped_file.h"
+#include "packed_position.h"
+#include <span>
+#include <stddef.h>
+#include <string>
+
+// Streams records to a file through a large buffer. Direct I/O bypasses the
+// page cache, so long generation runs don't evict everything else from
+// memory. Not thread safe.
+class TrainingDataWriter {
+public:
+  TrainingDataWriter() = default;
+  TrainingDataWriter(TrainingDataWriter const &) = delete;
+  TrainingDataWriter &operator=(TrainingDataWriter const &) = delete;
+  ~TrainingDataWriter();
+
+  // Falls back to buffered writes when direct I/O is not available.
+  bool Open(std::string const &path, size_t buffer_bytes, bool direct_io);
+  bool Write(PackedPosition const &record);
+  bool Close();
+
+  bool IsDirectIO() const { return _direct_io; }
+
+private:
+  bool Flush();
+
+  int _fd = -1;
+  bool _direct_io = false;
+  PackedPosition *_buffer = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+};
+
+// Maps a file written by TrainingDataWriter into memory.
+class TrainingDataReader {
+public:
+  bool Open(std::string const &path);
+  void Close();
+
+  std::span<PackedPosition const> Records() const { return _records; }
+
+private:
+  MappedFile _file;
+  std::span<PackedPosition const> _records;
+};
\ No newline at end of file
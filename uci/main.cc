@@ -1,13 +1,19 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <istream>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 
 #include "engine/engine.h"
 #include "engine/position.h"
 
+static constexpr int64_t kMinHashMegabytes = 1;
+static constexpr int64_t kMaxHashMegabytes = 65536;
+
 class UCI {
 public:
   UCI(std::istream &uci_in, std::ostream &uci_out)
@@ -17,10 +23,20 @@ public:
 
 private:
   void handlePosition(std::istream &stream);
+  void handleGo(std::istream &stream, Engine &engine);
+  void handleSetOption(std::istream &stream, Engine &engine);
+  void handleHashFile(std::string const &command, std::istream &stream,
+                      Engine &engine);
+  void printHashInfo(Engine const &engine);
+  void printInfo(SearchInfo const &info);
+  void printBestMove(Move best, Move ponder);
   void printError(std::string msg);
+  void send(std::string const &line);
 
   std::istream &_uci_in;
   std::ostream &_uci_out;
+  // The search thread reports while commands are still being answered.
+  std::mutex _out_mutex;
   bool _fatal_error;
   Position _last_position;
 };
@@ -35,35 +51,44 @@ void UCI::run() {
     stream >> command;
 
     if (command == "uci") {
-      _uci_out << "id name Sami's Chess Engine" << std::endl;
-      _uci_out << "id author Sami Kalliomäki" << std::endl;
-      _uci_out << "uciok" << std::endl;
+      send("id name Sami's Chess Engine");
+      send("id author Sami Kalliomäki");
+      send("option name Hash type spin default " +
+           std::to_string(kDefaultHashMegabytes) + " min " +
+           std::to_string(kMinHashMegabytes) + " max " +
+           std::to_string(kMaxHashMegabytes));
+      send("option name Ponder type check default false");
+      for (SearchOptionInfo const &option : kSearchOptions) {
+        send(std::string("option name ") + option.name +
+             " type check default " +
+             (SearchOptions().*option.value ? "true" : "false"));
+      }
+      send("uciok");
+      printHashInfo(*engine);
     } else if (command == "debug") {
       // Do nothing...
     } else if (command == "isready") {
-      _uci_out << "readyok" << std::endl;
+      send("readyok");
     } else if (command == "setoption") {
-      // Do nothing...
+      handleSetOption(stream, *engine);
     } else if (command == "register") {
       // Do nothing...
     } else if (command == "ucinewgame") {
-      engine = std::make_unique<Engine>();
+      engine->NewGame();
     } else if (command == "position") {
       handlePosition(stream);
     } else if (command == "go") {
-      engine->EnterPosition(_last_position);
-      engine->StartSearch();
-      _uci_out << "bestmove "
-               << ToNotation(_last_position, engine->GetBestMove())
-               << std::endl;
+      handleGo(stream, *engine);
     } else if (command == "stop") {
-      // Do nothing...
+      engine->Stop();
     } else if (command == "ponderhit") {
-      // Do nothing...
+      engine->PonderHit();
+    } else if (command == "savehash" || command == "loadhash") {
+      handleHashFile(command, stream, *engine);
     } else if (command == "quit") {
       return;
     } else {
-      _uci_out << "info string Unknown command: " << command << std::endl;
+      send("info string Unknown command: " + command);
     }
   }
 }
@@ -72,34 +97,169 @@ void UCI::handlePosition(std::istream &stream) {
   std::string format;
   stream >> format;
 
+  std::string move;
   if (format == "startpos") {
     _last_position = GetStartingPosition();
+    stream >> move;
   } else if (format == "fen") {
-    printError("Does not support fen positions yet");
-    return;
+    std::string fen;
+    while (stream >> move && move != "moves") {
+      fen += move + ' ';
+    }
+    if (!ParseFen(fen, _last_position)) {
+      printError("Invalid fen: " + fen);
+      return;
+    }
   } else {
     printError("Unknown format: " + format);
     return;
   }
 
-  std::string move;
-  stream >> move;
+  // The moves are optional.
+  if (!stream)
+    return;
   if (move != "moves") {
     printError("expected moves");
     return;
   }
 
-  while (!stream.eof()) {
-    stream >> move;
+  while (stream >> move) {
     PlayMove(_last_position, GetMove(move));
   }
 }
 
+void UCI::handleGo(std::istream &stream, Engine &engine) {
+  bool white = _last_position.active_player == Player::kWhite;
+  SearchLimits limits;
+
+  std::string token;
+  while (stream >> token) {
+    int64_t value = 0;
+    if (token == "infinite") {
+      limits.infinite = true;
+    } else if (token == "ponder") {
+      limits.ponder = true;
+    } else if (token == "depth" && stream >> value) {
+      limits.depth = (int)value;
+    } else if (token == "movetime" && stream >> value) {
+      limits.move_time = std::chrono::milliseconds(value);
+    } else if (token == (white ? "wtime" : "btime") && stream >> value) {
+      limits.time_left = std::chrono::milliseconds(value);
+    } else if (token == (white ? "winc" : "binc") && stream >> value) {
+      limits.increment = std::chrono::milliseconds(value);
+    }
+  }
+
+  // Without any limits search until told to stop.
+  if (limits.depth == 0 && limits.move_time.count() == 0 &&
+      limits.time_left.count() == 0) {
+    limits.infinite = true;
+  }
+
+  engine.EnterPosition(_last_position);
+  engine.StartSearch(
+      limits, [this](Move best, Move ponder) { printBestMove(best, ponder); },
+      [this](SearchInfo const &info) { printInfo(info); });
+}
+
+void UCI::handleSetOption(std::istream &stream, Engine &engine) {
+  std::string token, name, value;
+  stream >> token;
+  if (token != "name") {
+    printError("expected name");
+    return;
+  }
+
+  while (stream >> token && token != "value") {
+    name += (name.empty() ? "" : " ") + token;
+  }
+  while (stream >> token) {
+    value += (value.empty() ? "" : " ") + token;
+  }
+
+  if (name == "Hash") {
+    std::istringstream value_stream(value);
+    int64_t megabytes = 0;
+    if (!(value_stream >> megabytes) || !(value_stream >> std::ws).eof()) {
+      send("info string Invalid Hash value: " + value);
+      return;
+    }
+    engine.SetHashSize(
+        std::clamp(megabytes, kMinHashMegabytes, kMaxHashMegabytes));
+    printHashInfo(engine);
+  } else if (name == "Ponder") {
+    // Pondering is driven by the GUI.
+  } else if (!engine.SetOption(name, value)) {
+    send("info string Unknown option or invalid value: " + name + " " +
+         value);
+  }
+}
+
+// Non-standard commands: savehash <file> and loadhash <file>.
+void UCI::handleHashFile(std::string const &command, std::istream &stream,
+                         Engine &engine) {
+  std::string path;
+  std::getline(stream >> std::ws, path);
+  if (path.empty()) {
+    send("info string Expected a file name");
+    return;
+  }
+
+  bool ok = command == "savehash" ? engine.SaveHash(path)
+                                  : engine.LoadHash(path);
+  send("info string " + command + (ok ? " done: " : " failed: ") + path);
+}
+
+void UCI::printHashInfo(Engine const &engine) {
+  TranspositionTable const &table = engine.GetHashTable();
+  if (table.GetSizeBytes() == 0) {
+    send("info string Hash table allocation failed, searching without one");
+    return;
+  }
+  send("info string Hash " + std::to_string(table.GetSizeBytes() >> 20) +
+       " MB with " + GetPageModeName(table.GetPageMode()));
+}
+
+void UCI::printInfo(SearchInfo const &info) {
+  std::ostringstream line;
+  line << "info depth " << info.depth;
+  if (info.mate != 0) {
+    line << " score mate " << info.mate;
+  } else {
+    line << " score cp " << info.score_cp;
+  }
+  line << " nodes " << info.nodes << " time " << info.time.count();
+  if (info.time.count() > 0) {
+    line << " nps " << info.nodes * 1000 / info.time.count();
+  }
+  line << " pv";
+  for (Move const &move : info.pv) {
+    line << ' ' << ToNotation(_last_position, move);
+  }
+  send(line.str());
+}
+
+void UCI::printBestMove(Move best, Move ponder) {
+  if (IsNullMove(best)) {
+    send("bestmove 0000");
+  } else if (IsNullMove(ponder)) {
+    send("bestmove " + ToNotation(_last_position, best));
+  } else {
+    send("bestmove " + ToNotation(_last_position, best) + " ponder " +
+         ToNotation(_last_position, ponder));
+  }
+}
+
 void UCI::printError(std::string msg) {
-  _uci_out << "info string Error: " << msg << std::endl;
+  send("info string Error: " + msg);
   _fatal_error = true;
 }
 
+void UCI::send(std::string const &line) {
+  std::lock_guard<std::mutex> lock(_out_mutex);
+  _uci_out << line << std::endl;
+}
+
 int main() {
   UCI uci(std::cin, std::cout);
   uci.run();